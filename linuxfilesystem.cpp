@@ -1,23 +1,43 @@
+#include <set>
 #include <list>
 #include <ctime>
+#include <cerrno>
+#include <mutex>
+#include <queue>
+#include <bitset>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <climits>
+#include <cstdint>
+#include <cstring>
 #include <vector>
+#include <algorithm>
 #include <iomanip>
 #include <sstream>
 #include <iostream>
+#include <stdexcept>
+#include <functional>
 #include <unordered_map>
+#include <condition_variable>
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <unistd.h>
+#endif
 
 using namespace std;
 
-string curr_time();
+long long curr_time();
+string format_time(long long ns);
 
 class TreeNode
 {
 public:
     string name;
-    list<string> contents;
+    vector<uint32_t> blocks; // file contents, as block ids in content_store
     char type;
-    string cdate;
-    string mdate;
+    long long cdate; // nanoseconds since the epoch, formatted on demand
+    long long mdate;
     int permission;
     TreeNode *parent;
     TreeNode *link;
@@ -25,7 +45,7 @@ public:
 
     TreeNode(TreeNode *pwd, const std::string &name)
         : name(name), parent(pwd), permission(6),
-          cdate(curr_time()), mdate(curr_time()),
+          cdate(curr_time()), mdate(cdate),
           link(nullptr), child(nullptr) {}
 
     std::string get_permission() const
@@ -40,13 +60,169 @@ public:
     ~TreeNode() = default;
 };
 
+// Every node ordered by modification time, so that find -newer / -mtime
+// scans only the nodes modified in range instead of walking the tree. That
+// is O(log n + k) for find /; under a narrower P every node in range anywhere
+// in the namespace is still visited and pays an O(depth) ancestor check.
+set<pair<long long, TreeNode *>> mtime_index;
+
+// Fixed-size content blocks kept in a bounded LRU cache and written
+// through to an unlinked temporary backing file, so file contents are not
+// limited by memory. Worker threads pread blocks ahead of sequential reads.
+// Without a backing file (Windows, or tmpfile failed) every block stays
+// resident in the cache. I/O failures leave their errno in error.
+class BlockStore
+{
+public:
+    static const size_t BLOCK = 4096;
+
+    BlockStore(size_t capacity, int workers);
+    ~BlockStore();
+
+    bool write(const string &data, uint32_t &id);
+    bool read(uint32_t id, string &data);
+    bool spills() const { return backing != nullptr; }
+    void prefetch(const vector<uint32_t> &ids);
+    void release(uint32_t id);
+    void print_stats();
+
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+    size_t prefetched = 0;
+    long long read_ns = 0;
+    long long max_read_ns = 0;
+    int error = 0;
+
+private:
+    int load(uint32_t id, string &data);
+    int save(uint32_t id, const string &data);
+    void insert(uint32_t id, const string &data);
+    void work();
+
+    size_t capacity;
+    int fd;
+    FILE *backing;
+    vector<uint32_t> lengths;
+    vector<uint32_t> free_ids;
+    list<pair<uint32_t, string>> lru;
+    unordered_map<uint32_t, list<pair<uint32_t, string>>::iterator> cache;
+    set<uint32_t> queued;    // waiting for a worker, the reader may take these over
+    set<uint32_t> in_flight; // being read by a worker
+    queue<uint32_t> requests;
+    bool stopping = false;
+    mutex lock;
+    condition_variable work_cv;
+    condition_variable done_cv;
+    vector<thread> threads;
+};
+
+// Created in main so a missing backing file can be reported
+BlockStore *content_store = nullptr;
+const size_t READAHEAD = 8;
+
+// Bit vector with rank/select, one 32-bit count per 512 bits
+class BitVector
+{
+public:
+    vector<uint64_t> words;
+    vector<uint32_t> ranks;
+    size_t length = 0;
+
+    void push_back(bool bit);
+    void build();
+    size_t rank1(size_t pos) const; // ones in [0, pos)
+    size_t rank0(size_t pos) const { return pos - rank1(pos); }
+    size_t select1(size_t k) const; // position of the k-th one, from 0
+    size_t select0(size_t k) const; // position of the k-th zero, from 0
+    size_t bytes() const { return words.size() * sizeof(uint64_t) + ranks.size() * sizeof(uint32_t); }
+};
+
+void put_varint(string &out, uint32_t value);
+uint32_t get_varint(const string &in, size_t &pos);
+
+// Immutable copy of the namespace built by freeze. Nodes are numbered in
+// BFS order: the topology is a LOUDS bit vector of 2n + 1 bits, names are
+// front coded in buckets and metadata lives in flat arrays indexed by id.
+class FrozenTree
+{
+public:
+    static const uint32_t NONE = UINT32_MAX;
+    static const uint32_t BUCKET = 16;
+
+    explicit FrozenTree(TreeNode *root);
+
+    uint32_t size() const { return count; }
+    uint32_t parent(uint32_t id) const;
+    uint32_t first_child(uint32_t id) const;
+    uint32_t degree(uint32_t id) const;
+    uint32_t find_child(uint32_t dir, const string &name) const;
+    vector<string> names(uint32_t first, uint32_t n) const;
+    string name(uint32_t id) const { return names(id, 1).front(); }
+    string path(uint32_t id) const;
+    char type(uint32_t id) const { return (meta[id] & 8) ? 'd' : '-'; }
+    string get_permission(uint32_t id) const;
+    long long mdate(uint32_t id) const { return mdates[id]; }
+    long long cdate(uint32_t id) const { return cdates[id]; }
+    vector<uint32_t> blocks(uint32_t id) const;
+    vector<uint32_t> mtime_range(long long lo, long long hi) const;
+    void print_stats() const;
+
+private:
+    // Decode names first..first+n-1 in order, stopping early if fn returns true
+    template <typename Fn>
+    void scan_names(uint32_t first, uint32_t n, Fn fn) const
+    {
+        if (n == 0)
+        {
+            return;
+        }
+        string cur;
+        size_t pos = name_buckets[first / BUCKET];
+        for (uint32_t id = first / BUCKET * BUCKET; id < first + n; id++)
+        {
+            uint32_t lcp = get_varint(name_table, pos);
+            uint32_t len = get_varint(name_table, pos);
+            cur.resize(lcp);
+            cur.append(name_table, pos, len);
+            pos += len;
+            if (id >= first && fn(id, cur))
+            {
+                return;
+            }
+        }
+    }
+
+    uint32_t count;
+    BitVector louds;
+    string name_table;
+    vector<uint32_t> name_buckets;
+    vector<uint8_t> meta; // permission bits, plus 8 for directories
+    vector<long long> cdates;
+    vector<long long> mdates;
+    vector<uint32_t> content_blocks;
+    vector<uint32_t> content_offsets;
+    vector<uint32_t> by_mtime;
+};
+
 void linux_tree(TreeNode *root);
 void print_help();
+bool run_frozen(FrozenTree &fs, uint32_t &pwd, list<string> args, const string &cmd);
+uint32_t frozen_cd(const FrozenTree &fs, uint32_t pwd, string path);
+void frozen_ls(const FrozenTree &fs, uint32_t dir);
+void frozen_tree(const FrozenTree &fs, uint32_t dir, string prev);
+list<string> frozen_find(const FrozenTree &fs, uint32_t dir, string name);
+void frozen_cat(const FrozenTree &fs, uint32_t pwd, string path, string pattern);
 void print_tree(TreeNode *root, string prev);
 void print_ls(TreeNode *pwd);
 void print_stat(TreeNode *root, TreeNode *pwd, string path);
 string pwd_str(TreeNode *root, TreeNode *pwd);
 list<string> find_names(TreeNode *root, TreeNode *pwd, string name);
+list<string> find_mtime(TreeNode *root, TreeNode *dir, long long lo, long long hi);
+bool mtime_range(TreeNode *root, TreeNode *pwd, string test, string value, long long &lo, long long &hi);
+bool mtime_days(string value, long long &lo, long long &hi);
+bool is_under(TreeNode *dir, TreeNode *node);
+void set_mdate(TreeNode *node, long long mdate);
 TreeNode *find_node(TreeNode *root, TreeNode *pwd, string path);
 TreeNode *find_on_pwd(TreeNode *pwd, string name);
 list<string> split(string str, char delim);
@@ -57,15 +233,32 @@ TreeNode *create(TreeNode *root, TreeNode *pwd, string path, char type);
 void remove(TreeNode *root, TreeNode *pwd, string path);
 void dupl(TreeNode *root, TreeNode *pwd, string src, string dst, int keep);
 void edit(TreeNode *root, TreeNode *pwd, string path);
-void cat(TreeNode *root, TreeNode *pwd, string path);
+void cat(TreeNode *root, TreeNode *pwd, string path, string pattern);
+bool write_contents(TreeNode *file, const list<string> &lines);
+bool read_lines(BlockStore &store, const vector<uint32_t> &blocks, size_t readahead, function<void(const string &)> fn);
+bool print_lines(const vector<uint32_t> &blocks, const string &pattern);
 void chmod(TreeNode *root, TreeNode *pwd, string path, string new_modes);
 void clear_screen();
+void bench_create(int n);
+void bench_nav(int n);
+void bench_cache(int n);
+void free_tree(TreeNode *node);
 
 int main()
 {
     TreeNode *root = new TreeNode(nullptr, "");
     root->type = 'd';
+    mtime_index.insert({root->mdate, root});
     TreeNode *pwd = root;
+    FrozenTree *frozen = nullptr;
+    uint32_t frozen_pwd = 0;
+    // 1 MiB of cached blocks, two readahead workers
+    content_store = new BlockStore(256, 2);
+    if (content_store->error != 0)
+    {
+        std::cout << "warning: cannot create content backing file: " << strerror(content_store->error)
+                  << ", file contents stay in memory" << std::endl;
+    }
     linux_tree(root);
 
     cout << endl;
@@ -79,7 +272,41 @@ int main()
         std::list<std::string> args = split(cmd, ' ');
         TreeNode *temp_pwd = nullptr;
 
-        if (cmd == "help")
+        if (frozen != nullptr && run_frozen(*frozen, frozen_pwd, args, cmd))
+        {
+            // handled read-only on the frozen encoding
+        }
+        else if (cmd == "freeze")
+        {
+            if (frozen != nullptr)
+            {
+                std::cout << "freeze: already frozen" << std::endl;
+            }
+            else
+            {
+                frozen = new FrozenTree(root);
+                frozen_pwd = frozen_cd(*frozen, 0, pwd_str(root, pwd));
+                frozen->print_stats();
+            }
+        }
+        else if (cmd == "thaw")
+        {
+            if (frozen == nullptr)
+            {
+                std::cout << "thaw: not frozen" << std::endl;
+            }
+            else
+            {
+                temp_pwd = cd(root, root, frozen->path(frozen_pwd));
+                if (temp_pwd != nullptr)
+                {
+                    pwd = temp_pwd;
+                }
+                delete frozen;
+                frozen = nullptr;
+            }
+        }
+        else if (cmd == "help")
         {
             print_help();
         }
@@ -150,6 +377,22 @@ int main()
             {
                 std::cout << "find: missing operand" << std::endl;
             }
+            else if (args.size() == 3 && (*next(args.begin()) == "-newer" || *next(args.begin()) == "-mtime"))
+            {
+                std::string path = args.front();
+                args.pop_front();
+                std::string test = args.front();
+                args.pop_front();
+                long long lo, hi;
+                temp_pwd = cd(root, pwd, path);
+                if (temp_pwd != nullptr && mtime_range(root, pwd, test, args.front(), lo, hi))
+                {
+                    for (const std::string &res : find_mtime(root, temp_pwd, lo, hi))
+                    {
+                        std::cout << res << std::endl;
+                    }
+                }
+            }
             else
             {
                 for (const string &arg : args)
@@ -256,30 +499,46 @@ int main()
         //         dupl(root, pwd, src, dst, keep);
         //     }
         // }
-        // else if (args.front() == "edit")
-        // {
-        //     args.pop_front();
-        //     if (args.empty())
-        //     {
-        //         std::cout << "edit: missing operand" << std::endl;
-        //     }
-        //     else
-        //     {
-        //         edit(root, pwd, args.front());
-        //     }
-        // }
-        // else if (args.front() == "cat")
-        // {
-        //     args.pop_front();
-        //     if (args.empty())
-        //     {
-        //         std::cout << "cat: missing operand" << std::endl;
-        //     }
-        //     else
-        //     {
-        //         cat(root, pwd, args.front());
-        //     }
-        // }
+        else if (args.front() == "edit")
+        {
+            args.pop_front();
+            if (args.empty())
+            {
+                std::cout << "edit: missing operand" << std::endl;
+            }
+            else
+            {
+                edit(root, pwd, args.front());
+            }
+        }
+        else if (args.front() == "cat")
+        {
+            args.pop_front();
+            if (args.empty())
+            {
+                std::cout << "cat: missing operand" << std::endl;
+            }
+            else
+            {
+                cat(root, pwd, args.front(), "");
+            }
+        }
+        else if (args.front() == "grep")
+        {
+            args.pop_front();
+            if (args.size() != 2)
+            {
+                std::cout << "grep: missing operand" << std::endl;
+            }
+            else
+            {
+                cat(root, pwd, args.back(), args.front());
+            }
+        }
+        else if (cmd == "cachestat")
+        {
+            content_store->print_stats();
+        }
         // else if (args.front() == "chmod")
         // {
         //     args.pop_front();
@@ -294,6 +553,41 @@ int main()
         //         chmod(root, pwd, args.front(), perm);
         //     }
         // }
+        else if (args.front() == "bench")
+        {
+            args.pop_front();
+            if (args.size() != 2 || (args.front() != "create" && args.front() != "nav" && args.front() != "cache"))
+            {
+                std::cout << "bench: usage: bench create|nav|cache N" << std::endl;
+            }
+            else
+            {
+                int n = 0;
+                try
+                {
+                    n = std::stoi(args.back());
+                }
+                catch (const std::exception &e)
+                {
+                }
+                if (n <= 0 || (args.front() == "cache" && n > INT_MAX / 10))
+                {
+                    std::cout << "bench: invalid count: " << args.back() << std::endl;
+                }
+                else if (args.front() == "create")
+                {
+                    bench_create(n);
+                }
+                else if (args.front() == "nav")
+                {
+                    bench_nav(n);
+                }
+                else
+                {
+                    bench_cache(n);
+                }
+            }
+        }
         else if (cmd == "clear")
         {
             clear_screen();
@@ -308,10 +602,12 @@ int main()
         }
 
         std::cout << std::endl
-                  << pwd_str(root, pwd) << ">> ";
+                  << (frozen != nullptr ? frozen->path(frozen_pwd) : pwd_str(root, pwd)) << ">> ";
     }
 
+    delete frozen;
     delete root;
+    delete content_store;
 
     std::cout << std::endl;
     return 0;
@@ -327,6 +623,8 @@ void print_help()
     std::cout << "\tpwd       -   print the current working directory" << std::endl;
     std::cout << "\tcd DIR    -   change directory to DIR" << std::endl;
     std::cout << "\tfind N    -   find file or directory named N" << std::endl;
+    std::cout << "\tfind P -newer F  -   find entries under P modified after F" << std::endl;
+    std::cout << "\tfind P -mtime N  -   find entries under P modified N days ago (+N older, -N newer)" << std::endl;
     std::cout << "\tstat P    -   print metadata of file or directory at path P" << std::endl;
     std::cout << "\tmkdir D   -   create a directory named D" << std::endl;
     std::cout << "\ttouch F   -   create a file named F" << std::endl;
@@ -336,7 +634,14 @@ void print_help()
     std::cout << "\tmv S D    -   move file or directory from S to D" << std::endl;
     std::cout << "\tedit P    -   edit the file at path P" << std::endl;
     std::cout << "\tcat P     -   print the contents of the file at path P" << std::endl;
+    std::cout << "\tgrep S P  -   print the lines of the file at path P containing S" << std::endl;
+    std::cout << "\tcachestat -   print content cache hit rate, evictions and read latency" << std::endl;
     std::cout << "\tchmod M P -   change permissions of the file at path P to mode M" << std::endl;
+    std::cout << "\tfreeze    -   switch to a read-only compact copy of the tree" << std::endl;
+    std::cout << "\tthaw      -   drop the frozen copy and return to the editable tree" << std::endl;
+    std::cout << "\tbench create N   -   time creation of N nodes with eager vs lazy timestamps" << std::endl;
+    std::cout << "\tbench nav N      -   compare navigation of N nodes in the mutable and frozen trees" << std::endl;
+    std::cout << "\tbench cache N    -   scan 10N blocks of contents through an N-block cache" << std::endl;
     std::cout << "\tclear     -   clear the console screen" << std::endl;
     std::cout << "\texit      -   exit the shell" << std::endl;
 }
@@ -382,7 +687,7 @@ void print_ls(TreeNode *pwd)
         print_ls(pwd->child);
         return;
     }
-    cout << pwd->name << "\t" << pwd->type << pwd->get_permission() << "\t" << pwd->mdate << endl;
+    cout << pwd->name << "\t" << pwd->type << pwd->get_permission() << "\t" << format_time(pwd->mdate) << endl;
     print_ls(pwd->link);
 }
 
@@ -394,8 +699,8 @@ void print_ls(TreeNode *pwd)
 //         cout << "File: " << temp->name << endl;
 //         cout << "Type: " << temp->type << endl;
 //         cout << "Permission: " << temp->get_permission() << endl;
-//         cout << "Created: " << temp->cdate << endl;
-//         cout << "Modified: " << temp->mdate << endl;
+//         cout << "Created: " << format_time(temp->cdate) << endl;
+//         cout << "Modified: " << format_time(temp->mdate) << endl;
 //     }
 //     else
 //     {
@@ -436,14 +741,97 @@ list<string> find_names(TreeNode *root, TreeNode *pwd, string name)
     return res;
 }
 
+list<string> find_mtime(TreeNode *root, TreeNode *dir, long long lo, long long hi)
+{
+    list<string> res;
+    for (auto it = mtime_index.lower_bound({lo, nullptr}); it != mtime_index.end() && it->first <= hi; ++it)
+    {
+        if (is_under(dir, it->second))
+        {
+            res.push_back(pwd_str(root, it->second));
+        }
+    }
+    return res;
+}
+
+bool mtime_range(TreeNode *root, TreeNode *pwd, string test, string value, long long &lo, long long &hi)
+{
+    lo = LLONG_MIN;
+    hi = LLONG_MAX;
+    if (test == "-newer")
+    {
+        TreeNode *ref = cd(root, pwd, value);
+        if (ref == nullptr)
+        {
+            return false;
+        }
+        lo = ref->mdate + 1;
+        return true;
+    }
+    return mtime_days(value, lo, hi);
+}
+
+bool mtime_days(string value, long long &lo, long long &hi)
+{
+    // -mtime N matches an age of N whole days, +N more than N, -N less than N
+    lo = LLONG_MIN;
+    hi = LLONG_MAX;
+    const long long day = 86400LL * 1000000000LL;
+    long long now = curr_time();
+    try
+    {
+        size_t pos = 0;
+        long long days = std::stoll(value, &pos);
+        // Keep days * day and the bounds derived from it inside long long
+        if (pos != value.size() || days > LLONG_MAX / day - 1 || days < -(LLONG_MAX / day - 1))
+        {
+            throw std::invalid_argument(value);
+        }
+        if (value[0] == '+')
+        {
+            hi = now - (days + 1) * day;
+        }
+        else if (value[0] == '-')
+        {
+            lo = now + days * day + 1;
+        }
+        else
+        {
+            lo = now - (days + 1) * day + 1;
+            hi = now - days * day;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cout << "find: invalid argument '" << value << "' to '-mtime'" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool is_under(TreeNode *dir, TreeNode *node)
+{
+    while (node != nullptr && node != dir)
+    {
+        node = node->parent;
+    }
+    return node != nullptr;
+}
+
+void set_mdate(TreeNode *node, long long mdate)
+{
+    mtime_index.erase({node->mdate, node});
+    node->mdate = mdate;
+    mtime_index.insert({node->mdate, node});
+}
+
 TreeNode *find_node(TreeNode *root, TreeNode *pwd, string path)
 {
-    list<string> paths = split(path, '/');
-    string last = paths.back();
-    paths.pop_back();
-    string prev = join(paths, '/');
-    TreeNode *temp = cd(root, pwd, prev);
-    return find_on_pwd(temp, last);
+    string *paths = split_name(path);
+    TreeNode *dir = cd(root, pwd, paths[0]);
+    TreeNode *node = dir == nullptr ? nullptr : find_on_pwd(dir->child, paths[1]);
+    delete[] paths;
+    return node;
 }
 
 TreeNode *find_on_pwd(TreeNode *pwd, string name)
@@ -555,6 +943,7 @@ TreeNode *create(TreeNode *root, TreeNode *pwd, string path, char type)
     }
     TreeNode *newNode = new TreeNode(dir, paths[1]);
     newNode->type = type;
+    mtime_index.insert({newNode->mdate, newNode});
     newNode->link = dir->child;
     dir->child = newNode;
     if (type == 'd')
@@ -601,6 +990,11 @@ void remove(TreeNode *root, TreeNode *pwd, string path)
     {
         prev->link = curr->link;
     }
+    mtime_index.erase({curr->mdate, curr});
+    for (uint32_t id : curr->blocks)
+    {
+        content_store->release(id);
+    }
     delete curr;
     cout << "rm: removed '" << path << "'" << endl;
 }
@@ -634,10 +1028,13 @@ void remove(TreeNode *root, TreeNode *pwd, string path)
 //     }
 //     TreeNode *newNode = new TreeNode(dst_dir, dst_paths[1]);
 //     newNode->type = src_node->type;
-//     newNode->contents = src_node->contents;
+//     list<string> lines;
+//     read_lines(*content_store, src_node->blocks, READAHEAD, [&](const string &line)
+//                { lines.push_back(line); });
+//     write_contents(newNode, lines);
 //     newNode->permission = src_node->permission;
 //     newNode->cdate = src_node->cdate;
-//     newNode->mdate = src_node->mdate;
+//     set_mdate(newNode, src_node->mdate);
 //     newNode->link = dst_dir->child;
 //     dst_dir->child = newNode;
 //     if (keep == 0)
@@ -647,42 +1044,126 @@ void remove(TreeNode *root, TreeNode *pwd, string path)
 //     cout << "cp: copied '" << src << "' to '" << dst << "'" << endl;
 // }
 
-// void edit(TreeNode *root, TreeNode *pwd, string path)
-// {
-//     TreeNode *file = find_node(root, pwd, path);
-//     if (file == nullptr)
-//     {
-//         std::cout << "edit: " << path << ": No such file or directory" << std::endl;
-//         return;
-//     }
-//     std::cout << "Enter new contents for " << path << " (end with an empty line):" << std::endl;
-//     file->contents.clear();
-//     std::string line;
-//     while (std::getline(std::cin, line))
-//     {
-//         if (line.empty())
-//         {
-//             break;
-//         }
-//         file->contents.push_back(line);
-//     }
-//     file->mdate = curr_time();
-//     cout << "edit: updated contents of '" << path << "'" << endl;
-// }
+void edit(TreeNode *root, TreeNode *pwd, string path)
+{
+    TreeNode *file = find_node(root, pwd, path);
+    if (file == nullptr)
+    {
+        std::cout << "edit: " << path << ": No such file or directory" << std::endl;
+        return;
+    }
+    std::cout << "Enter new contents for " << path << " (end with an empty line):" << std::endl;
+    list<string> lines;
+    std::string line;
+    while (std::getline(std::cin, line))
+    {
+        if (line.empty())
+        {
+            break;
+        }
+        lines.push_back(line);
+    }
+    if (!write_contents(file, lines))
+    {
+        std::cout << "edit: " << path << ": " << strerror(content_store->error) << std::endl;
+        return;
+    }
+    set_mdate(file, curr_time());
+    cout << "edit: updated contents of '" << path << "'" << endl;
+}
 
-// void cat(TreeNode *root, TreeNode *pwd, string path)
-// {
-//     TreeNode *file = find_node(root, pwd, path);
-//     if (file == nullptr)
-//     {
-//         std::cout << "cat: " << path << ": No such file or directory" << std::endl;
-//         return;
-//     }
-//     for (const std::string &line : file->contents)
-//     {
-//         std::cout << line << std::endl;
-//     }
-// }
+void cat(TreeNode *root, TreeNode *pwd, string path, string pattern)
+{
+    TreeNode *file = find_node(root, pwd, path);
+    if (file == nullptr)
+    {
+        std::cout << (pattern.empty() ? "cat: " : "grep: ") << path << ": No such file or directory" << std::endl;
+        return;
+    }
+    if (!print_lines(file->blocks, pattern))
+    {
+        std::cout << (pattern.empty() ? "cat: " : "grep: ") << path << ": " << strerror(content_store->error) << std::endl;
+    }
+}
+
+bool write_contents(TreeNode *file, const list<string> &lines)
+{
+    string text;
+    for (const string &line : lines)
+    {
+        text += line;
+        text.push_back('\n');
+    }
+    vector<uint32_t> blocks;
+    for (size_t pos = 0; pos < text.size(); pos += BlockStore::BLOCK)
+    {
+        uint32_t id;
+        if (!content_store->write(text.substr(pos, BlockStore::BLOCK), id))
+        {
+            // Keep the old contents and give back what was written so far
+            for (uint32_t written : blocks)
+            {
+                content_store->release(written);
+            }
+            return false;
+        }
+        blocks.push_back(id);
+    }
+    for (uint32_t id : file->blocks)
+    {
+        content_store->release(id);
+    }
+    file->blocks = blocks;
+    return true;
+}
+
+bool read_lines(BlockStore &store, const vector<uint32_t> &blocks, size_t readahead, function<void(const string &)> fn)
+{
+    string line, data;
+    size_t queued = 0;
+    for (size_t i = 0; i < blocks.size(); i++)
+    {
+        // Once half the readahead window is consumed, queue the next half in one batch
+        if (readahead > 0 && queued <= i + readahead / 2 && queued < blocks.size())
+        {
+            queued = max(queued, i + 1);
+            size_t end = min(blocks.size(), i + readahead + 1);
+            store.prefetch(vector<uint32_t>(blocks.begin() + queued, blocks.begin() + end));
+            queued = end;
+        }
+        if (!store.read(blocks[i], data))
+        {
+            return false;
+        }
+        for (char ch : data)
+        {
+            if (ch == '\n')
+            {
+                fn(line);
+                line.clear();
+            }
+            else
+            {
+                line.push_back(ch);
+            }
+        }
+    }
+    if (!line.empty())
+    {
+        fn(line);
+    }
+    return true;
+}
+
+bool print_lines(const vector<uint32_t> &blocks, const string &pattern)
+{
+    return read_lines(*content_store, blocks, READAHEAD, [&](const string &line)
+               {
+                   if (line.find(pattern) != string::npos)
+                   {
+                       std::cout << line << std::endl;
+                   } });
+}
 
 // void chmod(TreeNode *root, TreeNode *pwd, string path, string new_modes)
 // {
@@ -696,7 +1177,7 @@ void remove(TreeNode *root, TreeNode *pwd, string path)
 //     {
 //         int new_perm = std::stoi(new_modes, nullptr, 8);
 //         file->permission = new_perm;
-//         file->mdate = curr_time();
+//         set_mdate(file, curr_time());
 //         cout << "chmod: updated permissions of '" << path << "'" << endl;
 //     }
 //     catch (const std::exception &e)
@@ -705,20 +1186,977 @@ void remove(TreeNode *root, TreeNode *pwd, string path)
 //     }
 // }
 
-void clear_screen()
-{
-#if defined(_WIN32) || defined(_WIN64)
-    system("cls");
-#else
-    system("clear");
-#endif
-}
-
-string curr_time()
+bool run_frozen(FrozenTree &fs, uint32_t &pwd, list<string> args, const string &cmd)
 {
-    std::time_t t = std::time(nullptr);
-    std::tm tm = *std::localtime(&t);
-    std::ostringstream oss;
+    uint32_t temp_pwd = FrozenTree::NONE;
+    if (args.front() == "ls")
+    {
+        args.pop_front();
+        if (args.empty())
+        {
+            frozen_ls(fs, pwd);
+        }
+        for (const string &arg : args)
+        {
+            cout << arg << ":" << endl;
+            temp_pwd = frozen_cd(fs, pwd, arg);
+            if (temp_pwd != FrozenTree::NONE)
+            {
+                frozen_ls(fs, temp_pwd);
+            }
+        }
+    }
+    else if (args.front() == "tree")
+    {
+        args.pop_front();
+        if (args.empty())
+        {
+            frozen_tree(fs, pwd, "");
+        }
+        for (const string &arg : args)
+        {
+            cout << arg << ":\n.\n";
+            temp_pwd = frozen_cd(fs, pwd, arg);
+            if (temp_pwd != FrozenTree::NONE)
+            {
+                frozen_tree(fs, temp_pwd, "");
+            }
+        }
+    }
+    else if (cmd == "pwd")
+    {
+        cout << fs.path(pwd) << endl;
+    }
+    else if (args.front() == "cd")
+    {
+        args.pop_front();
+        temp_pwd = args.empty() ? 0 : frozen_cd(fs, pwd, args.front());
+        if (temp_pwd != FrozenTree::NONE)
+        {
+            pwd = temp_pwd;
+        }
+    }
+    else if (args.front() == "find")
+    {
+        args.pop_front();
+        if (args.empty())
+        {
+            cout << "find: missing operand" << endl;
+        }
+        else if (args.size() == 3 && (*next(args.begin()) == "-newer" || *next(args.begin()) == "-mtime"))
+        {
+            string path = args.front();
+            args.pop_front();
+            string test = args.front();
+            args.pop_front();
+            long long lo, hi;
+            temp_pwd = frozen_cd(fs, pwd, path);
+            if (temp_pwd == FrozenTree::NONE)
+            {
+                return true;
+            }
+            if (test == "-newer")
+            {
+                uint32_t ref = frozen_cd(fs, pwd, args.front());
+                if (ref == FrozenTree::NONE)
+                {
+                    return true;
+                }
+                lo = fs.mdate(ref) + 1;
+                hi = LLONG_MAX;
+            }
+            else if (!mtime_days(args.front(), lo, hi))
+            {
+                return true;
+            }
+            for (uint32_t id : fs.mtime_range(lo, hi))
+            {
+                uint32_t up = id;
+                while (up != FrozenTree::NONE && up != temp_pwd)
+                {
+                    up = fs.parent(up);
+                }
+                if (up != FrozenTree::NONE)
+                {
+                    cout << fs.path(id) << endl;
+                }
+            }
+        }
+        else
+        {
+            for (const string &arg : args)
+            {
+                list<string> res = frozen_find(fs, arg[0] == '/' ? 0 : pwd, arg);
+                if (res.empty())
+                {
+                    cout << "find: '" << arg << "': no such file or directory" << endl;
+                }
+                for (const string &path : res)
+                {
+                    cout << path << endl;
+                }
+            }
+        }
+    }
+    else if (args.front() == "cat")
+    {
+        args.pop_front();
+        if (args.empty())
+        {
+            cout << "cat: missing operand" << endl;
+        }
+        else
+        {
+            frozen_cat(fs, pwd, args.front(), "");
+        }
+    }
+    else if (args.front() == "grep")
+    {
+        args.pop_front();
+        if (args.size() != 2)
+        {
+            cout << "grep: missing operand" << endl;
+        }
+        else
+        {
+            frozen_cat(fs, pwd, args.back(), args.front());
+        }
+    }
+    else if (args.front() == "mkdir" || args.front() == "touch" || args.front() == "rm" ||
+             args.front() == "rmdir" || args.front() == "edit")
+    {
+        cout << args.front() << ": Read-only file system (thaw to make changes)" << endl;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+uint32_t frozen_cd(const FrozenTree &fs, uint32_t pwd, string path)
+{
+    if (path.empty())
+    {
+        return pwd;
+    }
+    if (path[0] == '/')
+    {
+        pwd = 0;
+        path = path.substr(1);
+    }
+    list<string> paths = split(path, '/');
+    for (const string &dir : paths)
+    {
+        if (dir == ".")
+        {
+            continue;
+        }
+        if (dir == "..")
+        {
+            if (fs.parent(pwd) != FrozenTree::NONE)
+            {
+                pwd = fs.parent(pwd);
+            }
+            continue;
+        }
+        pwd = fs.find_child(pwd, dir);
+        if (pwd == FrozenTree::NONE)
+        {
+            std::cout << "cd: " << path << ": No such file or directory" << std::endl;
+            return FrozenTree::NONE;
+        }
+    }
+    return pwd;
+}
+
+void frozen_ls(const FrozenTree &fs, uint32_t dir)
+{
+    uint32_t first = fs.first_child(dir);
+    vector<string> names = fs.names(first, fs.degree(dir));
+    for (uint32_t i = 0; i < names.size(); i++)
+    {
+        cout << names[i] << "\t" << fs.type(first + i) << fs.get_permission(first + i) << "\t"
+             << format_time(fs.mdate(first + i)) << endl;
+    }
+}
+
+void frozen_tree(const FrozenTree &fs, uint32_t dir, string prev)
+{
+    uint32_t first = fs.first_child(dir);
+    vector<string> names = fs.names(first, fs.degree(dir));
+    for (uint32_t i = 0; i < names.size(); i++)
+    {
+        string name = prev + "/" + names[i];
+        cout << name << endl;
+        frozen_tree(fs, first + i, name);
+    }
+}
+
+list<string> frozen_find(const FrozenTree &fs, uint32_t dir, string name)
+{
+    list<string> res;
+    uint32_t first = fs.first_child(dir);
+    vector<string> names = fs.names(first, fs.degree(dir));
+    for (uint32_t i = 0; i < names.size(); i++)
+    {
+        if (names[i] == name)
+        {
+            res.push_back(fs.path(first + i));
+        }
+        list<string> sub = frozen_find(fs, first + i, name);
+        res.insert(res.end(), sub.begin(), sub.end());
+    }
+    return res;
+}
+
+void frozen_cat(const FrozenTree &fs, uint32_t pwd, string path, string pattern)
+{
+    string *paths = split_name(path);
+    uint32_t dir = frozen_cd(fs, pwd, paths[0]);
+    uint32_t file = dir == FrozenTree::NONE ? dir : fs.find_child(dir, paths[1]);
+    delete[] paths;
+    if (file == FrozenTree::NONE)
+    {
+        std::cout << (pattern.empty() ? "cat: " : "grep: ") << path << ": No such file or directory" << std::endl;
+        return;
+    }
+    if (!print_lines(fs.blocks(file), pattern))
+    {
+        std::cout << (pattern.empty() ? "cat: " : "grep: ") << path << ": " << strerror(content_store->error) << std::endl;
+    }
+}
+
+BlockStore::BlockStore(size_t capacity, int workers) : capacity(capacity), fd(-1), backing(nullptr)
+{
+#if !defined(_WIN32) && !defined(_WIN64)
+    backing = tmpfile();
+    if (backing == nullptr)
+    {
+        error = errno;
+        return;
+    }
+    fd = fileno(backing);
+#endif
+    if (backing == nullptr)
+    {
+        return;
+    }
+    for (int i = 0; i < workers; i++)
+    {
+        threads.emplace_back(&BlockStore::work, this);
+    }
+}
+
+BlockStore::~BlockStore()
+{
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    work_cv.notify_all();
+    for (thread &t : threads)
+    {
+        t.join();
+    }
+    if (backing != nullptr)
+    {
+        fclose(backing);
+    }
+}
+
+bool BlockStore::write(const string &data, uint32_t &id)
+{
+    unique_lock<mutex> guard(lock);
+    id = lengths.size();
+    if (!free_ids.empty())
+    {
+        id = free_ids.back();
+        free_ids.pop_back();
+    }
+    else
+    {
+        lengths.push_back(0);
+    }
+    lengths[id] = data.size();
+    if (spills())
+    {
+        // Written through, so cached blocks are never dirty and eviction just drops them
+        guard.unlock();
+        int err = save(id, data);
+        guard.lock();
+        if (err != 0)
+        {
+            error = err;
+            free_ids.push_back(id);
+            return false;
+        }
+    }
+    insert(id, data);
+    return true;
+}
+
+bool BlockStore::read(uint32_t id, string &data)
+{
+    auto start = chrono::steady_clock::now();
+    unique_lock<mutex> guard(lock);
+    // A block still waiting in the queue is cheaper to read here than to wait for
+    queued.erase(id);
+    done_cv.wait(guard, [&]
+                 { return in_flight.count(id) == 0; });
+    auto it = cache.find(id);
+    if (it != cache.end())
+    {
+        hits++;
+        lru.splice(lru.begin(), lru, it->second);
+        data = it->second->second;
+    }
+    else
+    {
+        misses++;
+        data.assign(lengths[id], '\0');
+        guard.unlock();
+        int err = load(id, data);
+        guard.lock();
+        if (err != 0)
+        {
+            error = err;
+            return false;
+        }
+        insert(id, data);
+    }
+    long long ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    read_ns += ns;
+    max_read_ns = max(max_read_ns, ns);
+    return true;
+}
+
+void BlockStore::prefetch(const vector<uint32_t> &ids)
+{
+    {
+        lock_guard<mutex> guard(lock);
+        if (threads.empty())
+        {
+            return;
+        }
+        for (uint32_t id : ids)
+        {
+            if (cache.count(id) == 0 && queued.count(id) == 0 && in_flight.count(id) == 0)
+            {
+                queued.insert(id);
+                requests.push(id);
+            }
+        }
+    }
+    work_cv.notify_all();
+}
+
+void BlockStore::release(uint32_t id)
+{
+    unique_lock<mutex> guard(lock);
+    queued.erase(id);
+    done_cv.wait(guard, [&]
+                 { return in_flight.count(id) == 0; });
+    auto it = cache.find(id);
+    if (it != cache.end())
+    {
+        lru.erase(it->second);
+        cache.erase(it);
+    }
+    free_ids.push_back(id);
+}
+
+void BlockStore::print_stats()
+{
+    lock_guard<mutex> guard(lock);
+    size_t reads = hits + misses;
+    cout << "cache: " << cache.size() << "/" << capacity << " blocks of " << BLOCK << " bytes, "
+         << lengths.size() - free_ids.size() << " blocks stored"
+         << (spills() ? "" : ", no backing file (all blocks resident)") << endl;
+    cout << fixed << setprecision(1);
+    cout << "\treads:     " << reads << " (" << hits << " hits, " << misses << " misses, "
+         << (reads ? 100.0 * hits / reads : 0.0) << "% hit rate)" << endl;
+    cout << "\tevictions: " << evictions << ", prefetched: " << prefetched << endl;
+    cout << "\tlatency:   " << (reads ? read_ns / 1000.0 / reads : 0.0) << " us avg, "
+         << max_read_ns / 1000.0 << " us max" << endl;
+    cout << defaultfloat << setprecision(6);
+}
+
+void BlockStore::insert(uint32_t id, const string &data)
+{
+    if (cache.count(id) != 0)
+    {
+        return;
+    }
+    lru.emplace_front(id, data);
+    cache[id] = lru.begin();
+    while (spills() && cache.size() > capacity)
+    {
+        cache.erase(lru.back().first);
+        lru.pop_back();
+        evictions++;
+    }
+}
+
+void BlockStore::work()
+{
+    unique_lock<mutex> guard(lock);
+    while (true)
+    {
+        work_cv.wait(guard, [&]
+                     { return stopping || !requests.empty(); });
+        if (stopping)
+        {
+            return;
+        }
+        uint32_t id = requests.front();
+        requests.pop();
+        if (queued.erase(id) == 0)
+        {
+            continue; // already read or released by the caller
+        }
+        in_flight.insert(id);
+        string data(lengths[id], '\0');
+        guard.unlock();
+        bool ok = load(id, data) == 0;
+        guard.lock();
+        if (ok)
+        {
+            insert(id, data);
+            prefetched++;
+        }
+        in_flight.erase(id);
+        done_cv.notify_all();
+    }
+}
+
+int BlockStore::load(uint32_t id, string &data)
+{
+#if defined(_WIN32) || defined(_WIN64)
+    return ENOSYS;
+#else
+    ssize_t n = pread(fd, &data[0], data.size(), off_t(id) * BLOCK);
+    return n == ssize_t(data.size()) ? 0 : n < 0 ? errno : EIO;
+#endif
+}
+
+int BlockStore::save(uint32_t id, const string &data)
+{
+#if defined(_WIN32) || defined(_WIN64)
+    return ENOSYS;
+#else
+    ssize_t n = pwrite(fd, data.data(), data.size(), off_t(id) * BLOCK);
+    return n == ssize_t(data.size()) ? 0 : n < 0 ? errno : ENOSPC;
+#endif
+}
+
+void BitVector::push_back(bool bit)
+{
+    if (length % 64 == 0)
+    {
+        words.push_back(0);
+    }
+    if (bit)
+    {
+        words.back() |= uint64_t(1) << (length % 64);
+    }
+    length++;
+}
+
+void BitVector::build()
+{
+    ranks.assign(words.size() / 8 + 1, 0);
+    uint32_t ones = 0;
+    for (size_t i = 0; i < words.size(); i++)
+    {
+        if (i % 8 == 0)
+        {
+            ranks[i / 8] = ones;
+        }
+        ones += bitset<64>(words[i]).count();
+    }
+    if (words.size() % 8 == 0)
+    {
+        ranks.back() = ones;
+    }
+}
+
+size_t BitVector::rank1(size_t pos) const
+{
+    size_t res = ranks[pos / 512];
+    for (size_t i = pos / 512 * 8; i < pos / 64; i++)
+    {
+        res += bitset<64>(words[i]).count();
+    }
+    if (pos % 64 != 0)
+    {
+        res += bitset<64>(words[pos / 64] & ((uint64_t(1) << (pos % 64)) - 1)).count();
+    }
+    return res;
+}
+
+size_t BitVector::select1(size_t k) const
+{
+    // last block whose leading count is <= k, then scan its words
+    size_t block = upper_bound(ranks.begin(), ranks.end(), k) - ranks.begin() - 1;
+    k -= ranks[block];
+    for (size_t i = block * 8; i < words.size(); i++)
+    {
+        size_t ones = bitset<64>(words[i]).count();
+        if (k < ones)
+        {
+            for (size_t bit = 0;; bit++)
+            {
+                if ((words[i] >> bit & 1) && k-- == 0)
+                {
+                    return i * 64 + bit;
+                }
+            }
+        }
+        k -= ones;
+    }
+    return length;
+}
+
+size_t BitVector::select0(size_t k) const
+{
+    size_t lo = 0, hi = ranks.size();
+    while (hi - lo > 1)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (mid * 512 - ranks[mid] <= k)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    k -= lo * 512 - ranks[lo];
+    for (size_t i = lo * 8; i < words.size(); i++)
+    {
+        size_t zeros = 64 - bitset<64>(words[i]).count();
+        if (k < zeros)
+        {
+            for (size_t bit = 0;; bit++)
+            {
+                if (!(words[i] >> bit & 1) && k-- == 0)
+                {
+                    return i * 64 + bit;
+                }
+            }
+        }
+        k -= zeros;
+    }
+    return length;
+}
+
+void put_varint(string &out, uint32_t value)
+{
+    while (value >= 128)
+    {
+        out.push_back(char((value & 127) | 128));
+        value >>= 7;
+    }
+    out.push_back(char(value));
+}
+
+uint32_t get_varint(const string &in, size_t &pos)
+{
+    uint32_t value = 0;
+    for (int shift = 0;; shift += 7)
+    {
+        uint8_t byte = in[pos++];
+        value |= uint32_t(byte & 127) << shift;
+        if (byte < 128)
+        {
+            return value;
+        }
+    }
+}
+
+FrozenTree::FrozenTree(TreeNode *root)
+{
+    // Super-root prefix "10", then each node's degree in unary, in BFS order
+    louds.push_back(1);
+    louds.push_back(0);
+    vector<TreeNode *> order{root};
+    string prev;
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        TreeNode *node = order[i];
+        for (TreeNode *child = node->child; child != nullptr; child = child->link)
+        {
+            order.push_back(child);
+            louds.push_back(1);
+        }
+        louds.push_back(0);
+
+        // Front coding: the first name of each bucket is stored whole, the
+        // rest as the length shared with the previous name plus a suffix
+        size_t lcp = 0;
+        if (i % BUCKET == 0)
+        {
+            name_buckets.push_back(name_table.size());
+        }
+        else
+        {
+            while (lcp < prev.size() && lcp < node->name.size() && prev[lcp] == node->name[lcp])
+            {
+                lcp++;
+            }
+        }
+        put_varint(name_table, lcp);
+        put_varint(name_table, node->name.size() - lcp);
+        name_table.append(node->name, lcp, string::npos);
+        prev = node->name;
+
+        meta.push_back((node->permission & 7) | (node->type == 'd' ? 8 : 0));
+        cdates.push_back(node->cdate);
+        mdates.push_back(node->mdate);
+        content_offsets.push_back(content_blocks.size());
+        content_blocks.insert(content_blocks.end(), node->blocks.begin(), node->blocks.end());
+    }
+    content_offsets.push_back(content_blocks.size());
+    count = order.size();
+    louds.build();
+
+    by_mtime.resize(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        by_mtime[i] = i;
+    }
+    stable_sort(by_mtime.begin(), by_mtime.end(), [this](uint32_t a, uint32_t b)
+                { return mdates[a] < mdates[b]; });
+}
+
+uint32_t FrozenTree::parent(uint32_t id) const
+{
+    // The block holding node id's bit belongs to the node numbered zeros-before-it - 1
+    size_t zeros = louds.rank0(louds.select1(id));
+    return zeros == 0 ? NONE : zeros - 1;
+}
+
+uint32_t FrozenTree::first_child(uint32_t id) const
+{
+    return louds.rank1(louds.select0(id) + 1);
+}
+
+uint32_t FrozenTree::degree(uint32_t id) const
+{
+    return louds.select0(id + 1) - louds.select0(id) - 1;
+}
+
+uint32_t FrozenTree::find_child(uint32_t dir, const string &name) const
+{
+    uint32_t found = NONE;
+    scan_names(first_child(dir), degree(dir), [&](uint32_t id, const string &cur)
+               {
+                   if (cur == name)
+                   {
+                       found = id;
+                   }
+                   return found != NONE; });
+    return found;
+}
+
+vector<string> FrozenTree::names(uint32_t first, uint32_t n) const
+{
+    vector<string> res;
+    res.reserve(n);
+    scan_names(first, n, [&](uint32_t, const string &cur)
+               {
+                   res.push_back(cur);
+                   return false; });
+    return res;
+}
+
+string FrozenTree::path(uint32_t id) const
+{
+    string path = name(id);
+    while (parent(id) != NONE)
+    {
+        id = parent(id);
+        path = name(id) + "/" + path;
+    }
+    if (path.empty())
+    {
+        return "/";
+    }
+    return path;
+}
+
+string FrozenTree::get_permission(uint32_t id) const
+{
+    static const char *permissions[] = {"---", "--x", "-w-", "-wx", "r--", "r-x", "rw-", "rwx"};
+    return permissions[meta[id] & 7];
+}
+
+vector<uint32_t> FrozenTree::blocks(uint32_t id) const
+{
+    return vector<uint32_t>(content_blocks.begin() + content_offsets[id], content_blocks.begin() + content_offsets[id + 1]);
+}
+
+vector<uint32_t> FrozenTree::mtime_range(long long lo, long long hi) const
+{
+    auto begin = lower_bound(by_mtime.begin(), by_mtime.end(), lo, [this](uint32_t id, long long t)
+                             { return mdates[id] < t; });
+    auto end = upper_bound(begin, by_mtime.end(), hi, [this](long long t, uint32_t id)
+                           { return t < mdates[id]; });
+    return vector<uint32_t>(begin, end);
+}
+
+void FrozenTree::print_stats() const
+{
+    size_t metadata = meta.size() + (cdates.size() + mdates.size()) * sizeof(long long) +
+                      content_offsets.size() * sizeof(uint32_t) + by_mtime.size() * sizeof(uint32_t);
+    cout << "freeze: " << count << " nodes" << endl;
+    cout << "\ttopology: " << louds.bytes() << " bytes (" << fixed << setprecision(2)
+         << louds.bytes() * 8.0 / count << " bits/node)" << endl;
+    cout << "\tnames:    " << name_table.size() + name_buckets.size() * sizeof(uint32_t) << " bytes" << endl;
+    cout << "\tmetadata: " << metadata << " bytes (" << metadata / double(count) << " bytes/node)" << endl;
+    cout << "\tcontents: " << content_blocks.size() << " block ids" << defaultfloat << setprecision(6) << endl;
+}
+
+void clear_screen()
+{
+#if defined(_WIN32) || defined(_WIN64)
+    system("cls");
+#else
+    system("clear");
+#endif
+}
+
+long long curr_time()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+string format_time(long long ns)
+{
+    std::time_t t = ns / 1000000000LL;
+    std::tm tm = *std::localtime(&t);
+    std::ostringstream oss;
     oss << std::put_time(&tm, "%Y-%m-%d %H:%M:%S");
     return oss.str();
 }
+
+void bench_create(int n)
+{
+    TreeNode scratch(nullptr, "");
+    scratch.type = 'd';
+    vector<TreeNode *> nodes;
+    nodes.reserve(n);
+
+    // Run once formatting both dates per node, as the constructor used to, then lazily
+    for (int eager = 1; eager >= 0; eager--)
+    {
+        size_t formatted = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < n; i++)
+        {
+            TreeNode *node = new TreeNode(&scratch, "bench");
+            node->type = '-';
+            if (eager)
+            {
+                formatted += format_time(node->cdate).size() + format_time(node->mdate).size();
+            }
+            mtime_index.insert({node->mdate, node});
+            nodes.push_back(node);
+        }
+        std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+
+        for (TreeNode *node : nodes)
+        {
+            mtime_index.erase({node->mdate, node});
+            delete node;
+        }
+        nodes.clear();
+
+        cout << (eager ? "eager timestamp strings: " : "lazy integer timestamps: ")
+             << n << " nodes in " << fixed << setprecision(3) << secs.count() * 1000 << " ms ("
+             << setprecision(0) << (secs.count() > 0 ? n / secs.count() : 0) << " nodes/s)"
+             << defaultfloat << setprecision(6);
+        if (eager)
+        {
+            cout << ", " << formatted << " bytes formatted";
+        }
+        cout << endl;
+    }
+}
+
+void bench_nav(int n)
+{
+    // Synthetic namespace: n nodes, sixteen children per directory, built in BFS order
+    TreeNode *scratch = new TreeNode(nullptr, "");
+    scratch->type = 'd';
+    vector<TreeNode *> nodes{scratch};
+    for (int i = 1; i < n; i++)
+    {
+        TreeNode *dir = nodes[(i - 1) / 16];
+        dir->type = 'd';
+        TreeNode *node = new TreeNode(dir, "node" + to_string(i));
+        node->type = '-';
+        node->link = dir->child;
+        dir->child = node;
+        nodes.push_back(node);
+    }
+    FrozenTree fs(scratch);
+
+    mt19937 rng(42);
+    vector<string> paths;
+    for (int i = 0; i < 10000; i++)
+    {
+        paths.push_back(pwd_str(scratch, nodes[rng() % nodes.size()]));
+    }
+
+    size_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const string &path : paths)
+    {
+        found += cd(scratch, scratch, path) != nullptr;
+    }
+    std::chrono::duration<double> mutable_cd = std::chrono::steady_clock::now() - start;
+    start = std::chrono::steady_clock::now();
+    for (const string &path : paths)
+    {
+        found += frozen_cd(fs, 0, path) != FrozenTree::NONE;
+    }
+    std::chrono::duration<double> frozen_cd_secs = std::chrono::steady_clock::now() - start;
+
+    // Full depth-first walk, the access pattern of tree and find
+    size_t visited = 0;
+    start = std::chrono::steady_clock::now();
+    vector<TreeNode *> stack{scratch};
+    while (!stack.empty())
+    {
+        TreeNode *node = stack.back();
+        stack.pop_back();
+        visited += node->name.size();
+        for (TreeNode *child = node->child; child != nullptr; child = child->link)
+        {
+            stack.push_back(child);
+        }
+    }
+    std::chrono::duration<double> mutable_walk = std::chrono::steady_clock::now() - start;
+    start = std::chrono::steady_clock::now();
+    vector<uint32_t> ids{0};
+    while (!ids.empty())
+    {
+        uint32_t id = ids.back();
+        ids.pop_back();
+        uint32_t first = fs.first_child(id);
+        for (const string &name : fs.names(first, fs.degree(id)))
+        {
+            visited += name.size();
+            ids.push_back(first++);
+        }
+    }
+    std::chrono::duration<double> frozen_walk = std::chrono::steady_clock::now() - start;
+
+    size_t mutable_bytes = 0;
+    for (TreeNode *node : nodes)
+    {
+        mutable_bytes += sizeof(TreeNode) + (node->name.capacity() > 15 ? node->name.capacity() + 1 : 0);
+    }
+    free_tree(scratch);
+
+    cout << fixed << setprecision(3);
+    cout << "mutable: " << mutable_bytes / double(n) << " bytes/node ("
+         << 3 * sizeof(TreeNode *) << " of them pointers)" << endl;
+    fs.print_stats();
+    cout << fixed << setprecision(3);
+    cout << paths.size() << " path lookups: mutable " << mutable_cd.count() * 1000 << " ms, frozen "
+         << frozen_cd_secs.count() * 1000 << " ms" << endl;
+    cout << "full walk: mutable " << mutable_walk.count() * 1000 << " ms, frozen "
+         << frozen_walk.count() * 1000 << " ms (" << found << " found, " << visited << " name bytes)" << endl;
+    cout << defaultfloat << setprecision(6);
+}
+
+void bench_cache(int n)
+{
+    // Working set of 10n blocks in files of 64 blocks (the last one shorter), through an n-block cache
+    mt19937 rng(42);
+    size_t total = 10 * size_t(n);
+    vector<vector<uint32_t>> files((total + 63) / 64);
+    for (int run = 0; run < 3; run++)
+    {
+        BlockStore store(n, run == 0 ? 0 : 2);
+        if (!store.spills())
+        {
+            cout << "bench: no content backing file, nothing is evicted" << endl;
+            return;
+        }
+        string line(63, 'x');
+        line.push_back('\n');
+        string block;
+        while (block.size() < BlockStore::BLOCK)
+        {
+            block += line;
+        }
+        for (vector<uint32_t> &file : files)
+        {
+            file.clear();
+        }
+        for (size_t i = 0; i < total; i++)
+        {
+            uint32_t id;
+            if (!store.write(block, id))
+            {
+                cout << "bench: " << strerror(store.error) << endl;
+                return;
+            }
+            files[i / 64].push_back(id);
+        }
+        store.hits = store.misses = store.evictions = store.read_ns = store.max_read_ns = 0;
+
+        size_t lines = 0;
+        auto start = std::chrono::steady_clock::now();
+        if (run < 2)
+        {
+            for (const vector<uint32_t> &file : files)
+            {
+                if (!read_lines(store, file, run == 0 ? 0 : READAHEAD, [&](const string &)
+                                { lines++; }))
+                {
+                    cout << "bench: " << strerror(store.error) << endl;
+                    return;
+                }
+            }
+        }
+        else
+        {
+            string data;
+            for (size_t i = 0; i < total; i++)
+            {
+                size_t k = rng() % total;
+                if (!store.read(files[k / 64][k % 64], data))
+                {
+                    cout << "bench: " << strerror(store.error) << endl;
+                    return;
+                }
+                lines += data.size() / 64;
+            }
+        }
+        std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+
+        const char *names[] = {"sequential, no readahead", "sequential, readahead", "random blocks"};
+        cout << names[run] << ": " << lines << " lines in " << fixed << setprecision(3)
+             << secs.count() * 1000 << " ms" << defaultfloat << setprecision(6) << endl;
+        store.print_stats();
+    }
+}
+
+void free_tree(TreeNode *node)
+{
+    while (node != nullptr)
+    {
+        free_tree(node->child);
+        TreeNode *next = node->link;
+        delete node;
+        node = next;
+    }
+}